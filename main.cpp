@@ -37,6 +37,9 @@ String t_avail   = String(TOPIC_BASE) + "/availability";
 String t_state   = String(TOPIC_BASE) + "/state";
 String t_cmd     = String(TOPIC_BASE) + "/cmd";
 String t_ambient = String(TOPIC_BASE) + "/ambient";
+String t_telem   = String(TOPIC_BASE) + "/telemetry";   // opt-in CBOR stream
+String t_trace   = String(TOPIC_BASE) + "/trace";       // command latency traces
+String t_stats   = String(TOPIC_BASE) + "/stats";       // runtime analytics
 
 // --------------------- Pins (Waveshare board) ---------------------
 constexpr int PIN_G    = 1;   // fan
@@ -92,6 +95,7 @@ bool     y1_on = false;
 uint32_t y1_last_change = 0;  // seconds since boot
 bool     w1_on = false;
 bool     w2_on = false;
+bool     g_on  = false;
 uint32_t w_call_start = 0;    // when heat call started (for stage2 delay)
 
 // Protections / behavior (tweakable via /cmd JSON)
@@ -102,17 +106,41 @@ float    STAGE2_DELTA_F    = 2.0;   // stage 2 threshold
 uint32_t STAGE2_DELAY_SEC  = 600;   // wait before W2
 bool     FAN_WITH_HEAT     = false; // many furnaces manage blower
 
+// Binary telemetry (CBOR on t_telem). 0 = disabled; enable via {"telemetry_ms": 500}
+uint32_t TELEMETRY_MS      = 0;
+constexpr uint32_t TELEMETRY_MIN_MS = 100;
+constexpr uint32_t TELEMETRY_CFG_MS = 60000;  // resend tunables at least this often
+
 uint32_t now_s() { return millis() / 1000; }
-void setRelay(int pin, bool on) { digitalWrite(pin, on ? HIGH : LOW); }
+
+// What was last written to each relay pin (bit0 G, bit1 W1, bit2 W2, bit3 Y1).
+// Can differ from y1_on etc.: allOff() drops the pins without touching them.
+uint8_t relayOut = 0;
+void setRelay(int pin, bool on) {
+  digitalWrite(pin, on ? HIGH : LOW);
+  uint8_t bit = (pin == PIN_G) ? 1 : (pin == PIN_W1) ? 2 : (pin == PIN_W2) ? 4 : (pin == PIN_Y1) ? 8 : 0;
+  relayOut = on ? (relayOut | bit) : (relayOut & ~bit);
+}
+uint8_t relayBits() { return relayOut; }
+// Controller's view, restored by the replayer along with the pins
+uint8_t callBits() { return (g_on ? 1 : 0) | (w1_on ? 2 : 0) | (w2_on ? 4 : 0) | (y1_on ? 8 : 0); }
 void allOff() { setRelay(PIN_G,false); setRelay(PIN_W1,false); setRelay(PIN_W2,false); setRelay(PIN_Y1,false); }
 
 // --------------------- Prototypes ---------------------
 void publishDiscovery();
+void publishStatsDiscovery();
 void publishState();
+void publishTelemetry();
+void publishStats();
 void applyOutputs();
 void handleCmd(const JsonVariant& j);
 void handleAmbient(const JsonVariant& j);
 void onMqtt(char* topic, byte* payload, unsigned int len);
+void publishTraceStats();
+void captureStart();
+void captureRecord(uint8_t type, const void* a, size_t alen, const void* b = nullptr, size_t blen = 0);
+void captureRelays();
+void captureWeb(const char* path);
 void ensureMqtt();
 bool runConfigPortal(bool eraseWifi);
 void startWebServer();
@@ -120,7 +148,7 @@ void startWebServer();
 // --------------------- MQTT helpers ---------------------
 void publishAvailability(const char* s) { mqtt.publish(t_avail.c_str(), s, true); }
 
-void publishState() {
+size_t encodeState(char* buf, size_t cap) {
   StaticJsonDocument<512> d;
   d["mode"]            = hvacModeStr;
   d["action"]          = hvacAction;
@@ -134,11 +162,454 @@ void publishState() {
   d["stage2_delta_f"]  = STAGE2_DELTA_F;
   d["stage2_delay_s"]  = STAGE2_DELAY_SEC;
   d["fan_with_heat"]   = FAN_WITH_HEAT;
+  return serializeJson(d, buf, cap);
+}
+
+void publishState() {
   char buf[512];
-  size_t n = serializeJson(d, buf, sizeof(buf));
+  size_t n = encodeState(buf, sizeof(buf));
   mqtt.publish(t_state.c_str(), (const uint8_t*)buf, n, true);
 }
 
+// --------------------- Binary telemetry (CBOR) ---------------------
+// Compact alternative to the JSON state for high-rate logging. One CBOR map
+// per message with small integer keys (1 byte each). Static tunables are only
+// included when they changed since the last frame, on the first frame after
+// (re)connect / enable, and every TELEMETRY_CFG_MS so a subscriber that joins
+// late (the topic is not retained) gets them. Decode with tools/telemetry_decode.cpp.
+//
+// Keys: 0 seq, 1 uptime_ms, 2 mode (Mode enum), 3 action (0 idle, 1 cooling,
+//       2 heating, 3 fan), 4 current_temp, 5 target_temp, 6 humidity,
+//       7 relays as driven (bit0 G, bit1 W1, bit2 W2, bit3 Y1)
+//       16 min_on_s, 17 min_off_s, 18 deadband_f, 19 stage2_delta_f,
+//       20 stage2_delay_s, 21 fan_with_heat
+enum TelemKey : uint8_t {
+  TK_SEQ = 0, TK_UPTIME_MS, TK_MODE, TK_ACTION, TK_CUR_TEMP, TK_TGT_TEMP, TK_HUMIDITY, TK_RELAYS,
+  TK_MIN_ON = 16, TK_MIN_OFF, TK_DEADBAND, TK_S2_DELTA, TK_S2_DELAY, TK_FAN_W_HEAT
+};
+
+struct TelemConfig {
+  uint32_t min_on, min_off, s2_delay;
+  float    deadband, s2_delta;
+  bool     fan_w_heat;
+  bool operator==(const TelemConfig& o) const {
+    return min_on == o.min_on && min_off == o.min_off && s2_delay == o.s2_delay &&
+           deadband == o.deadband && s2_delta == o.s2_delta && fan_w_heat == o.fan_w_heat;
+  }
+};
+
+uint32_t    telemSeq       = 0;
+bool        telemCfgValid  = false;  // cleared on (re)connect to force a config frame
+TelemConfig telemLastCfg   = {};
+uint32_t    telemCfgAt     = 0;      // millis() of the last frame with the config block
+
+struct CborWriter {
+  uint8_t* buf; size_t cap; size_t n = 0;
+  CborWriter(uint8_t* b, size_t c) : buf(b), cap(c) {}
+  void put(uint8_t v) { if (n < cap) buf[n] = v; n++; }
+  void head(uint8_t major, uint32_t v) {
+    major <<= 5;
+    if      (v < 24)     { put(major | v); }
+    else if (v <= 0xFF)  { put(major | 24); put(v); }
+    else if (v <= 0xFFFF){ put(major | 25); put(v >> 8); put(v); }
+    else                 { put(major | 26); put(v >> 24); put(v >> 16); put(v >> 8); put(v); }
+  }
+  void map(uint32_t pairs)         { head(5, pairs); }
+  void u32(uint32_t v)             { head(0, v); }
+  void flag(bool b)                { put(b ? 0xF5 : 0xF4); }
+  void f32(float f) {
+    uint32_t u; memcpy(&u, &f, sizeof(u));
+    put(0xFA); put(u >> 24); put(u >> 16); put(u >> 8); put(u);
+  }
+  bool ok() const { return n <= cap; }
+};
+
+uint8_t actionCode() {
+  if (hvacAction == "cooling") return 1;
+  if (hvacAction == "heating") return 2;
+  if (hvacAction == "fan")     return 3;
+  return 0;
+}
+
+size_t encodeTelemetry(uint8_t* buf, size_t cap) {
+  TelemConfig cfg = { MIN_ON_SEC, MIN_OFF_SEC, STAGE2_DELAY_SEC, DEADBAND_F, STAGE2_DELTA_F, FAN_WITH_HEAT };
+  bool withCfg = !telemCfgValid || !(cfg == telemLastCfg) || millis() - telemCfgAt >= TELEMETRY_CFG_MS;
+
+  CborWriter w(buf, cap);
+  w.map(withCfg ? 14 : 8);
+  w.u32(TK_SEQ);        w.u32(telemSeq);
+  w.u32(TK_UPTIME_MS);  w.u32(millis());
+  w.u32(TK_MODE);       w.u32(hvacMode);
+  w.u32(TK_ACTION);     w.u32(actionCode());
+  w.u32(TK_CUR_TEMP);   w.f32(currentTempF);
+  w.u32(TK_TGT_TEMP);   w.f32(targetTempF);
+  w.u32(TK_HUMIDITY);   w.f32(humidity);
+  w.u32(TK_RELAYS);     w.u32(relayBits());
+  if (withCfg) {
+    w.u32(TK_MIN_ON);      w.u32(cfg.min_on);
+    w.u32(TK_MIN_OFF);     w.u32(cfg.min_off);
+    w.u32(TK_DEADBAND);    w.f32(cfg.deadband);
+    w.u32(TK_S2_DELTA);    w.f32(cfg.s2_delta);
+    w.u32(TK_S2_DELAY);    w.u32(cfg.s2_delay);
+    w.u32(TK_FAN_W_HEAT);  w.flag(cfg.fan_w_heat);
+  }
+  if (!w.ok()) return 0;
+
+  if (withCfg) { telemLastCfg = cfg; telemCfgValid = true; telemCfgAt = millis(); }
+  telemSeq++;
+  return w.n;
+}
+
+void publishTelemetry() {
+  uint8_t buf[96];   // worst case with config block is 69 bytes; 34-37 without on a running device
+  size_t n = encodeTelemetry(buf, sizeof(buf));
+  if (n) mqtt.publish(t_telem.c_str(), buf, n, false);
+}
+
+// --------------------- Command latency tracing ---------------------
+// A /cmd payload may carry "cid" (correlation id, string) and "ts" (sender
+// timestamp, opaque integer). Each stage of onMqtt() is stamped with micros();
+// traced commands get a JSON echo on t_trace after the state publish.
+// Commands feed the on-device histograms, dumped with {"trace_stats":true} and
+// cleared with {"trace_stats":"reset"}. Commands that block (portal) or write
+// a capture snapshot are left out so they don't swamp max_us.
+struct LatencyHist {
+  // Bucket i counts samples in [2^i, 2^(i+1)) us; last bucket is open-ended.
+  static constexpr int BUCKETS = 20;
+  uint32_t counts[BUCKETS] = {0};
+  uint32_t n = 0;
+  uint32_t max_us = 0;
+
+  void add(uint32_t us) {
+    int b = 0;
+    while (b < BUCKETS - 1 && (us >> (b + 1))) b++;
+    counts[b]++; n++;
+    if (us > max_us) max_us = us;
+  }
+  // Upper bound of the bucket holding the q-quantile (0 < q <= 1)
+  uint32_t quantileUpper(float q) const {
+    if (!n) return 0;
+    uint32_t want = (uint32_t)(q * n + 0.5f); if (!want) want = 1;
+    uint32_t seen = 0;
+    for (int b = 0; b < BUCKETS; b++) {
+      seen += counts[b];
+      if (seen >= want) return (b == BUCKETS - 1) ? max_us : (2u << b);
+    }
+    return max_us;
+  }
+};
+
+struct CmdTrace {
+  char     cid[40];
+  long long ts;
+  bool     hasTs;
+  uint32_t rx_us, parsed_us, handled_us, relay_us, pub_us;
+};
+
+LatencyHist histCmdToRelay;
+LatencyHist histCmdToPublish;
+bool        traceStatsPending = false;  // set by handleCmd, published by onMqtt
+bool        cmdUntimed        = false;  // set by handleCmd: keep this command out of the histograms
+
+void publishTrace(const CmdTrace& tr) {
+  StaticJsonDocument<256> d;
+  d["cid"]        = tr.cid;
+  if (tr.hasTs) d["ts"] = tr.ts;
+  d["parse_us"]   = tr.parsed_us  - tr.rx_us;
+  d["handle_us"]  = tr.handled_us - tr.parsed_us;
+  d["apply_us"]   = tr.relay_us   - tr.handled_us;
+  d["publish_us"] = tr.pub_us     - tr.relay_us;
+  d["to_relay_us"]   = tr.relay_us - tr.rx_us;
+  d["to_publish_us"] = tr.pub_us   - tr.rx_us;
+  char buf[256];
+  size_t n = serializeJson(d, buf, sizeof(buf));
+  mqtt.publish(t_trace.c_str(), (const uint8_t*)buf, n, false);
+}
+
+void histToJson(JsonObject o, const LatencyHist& h) {
+  o["n"]      = h.n;
+  o["p50_us"] = h.quantileUpper(0.50f);
+  o["p99_us"] = h.quantileUpper(0.99f);
+  o["max_us"] = h.max_us;
+  JsonArray b = o.createNestedArray("log2_buckets");
+  for (int i = 0; i < LatencyHist::BUCKETS; i++) b.add(h.counts[i]);
+}
+
+void publishTraceStats() {
+  StaticJsonDocument<1024> d;
+  histToJson(d.createNestedObject("cmd_to_relay"),   histCmdToRelay);
+  histToJson(d.createNestedObject("cmd_to_publish"), histCmdToPublish);
+  char buf[1024];
+  size_t n = serializeJson(d, buf, sizeof(buf));
+  mqtt.publish((t_trace + "/stats").c_str(), (const uint8_t*)buf, n, false);
+}
+
+// --------------------- Capture (record for host replay) ---------------------
+// {"capture":true} on /cmd streams a state snapshot, then every inbound MQTT
+// message, web POST and relay transition to the serial console as framed
+// binary records. Save with e.g. `cat /dev/ttyACM0 > capture.bin` and replay
+// in virtual time with tools/replay.cpp.
+//
+// Record: A5 5A | type | seq (u16 LE) | t_ms (u32 LE) | len (u16 LE) | data | sum8(type..data)
+//   seq counts records from 0 at the snapshot, so the replayer can tell when
+//   the serial link dropped one (HWCDC discards writes the host doesn't read).
+//   'S' snapshot  JSON (cmd/ambient keys + relays, calls, y1_last_change, w_call_start)
+//   'M' mqtt      topic \0 payload
+//   'W' web POST  path \0 name \0 value \0 ...
+//   'R' relays    1 byte, relayBits() (pin outputs, not the controller's calls)
+//   'D' dropped   type of the input that didn't fit, then its topic/path \0
+enum CaptureType : uint8_t {
+  CAP_SNAPSHOT = 'S', CAP_MQTT = 'M', CAP_WEB = 'W', CAP_RELAYS = 'R', CAP_DROPPED = 'D'
+};
+
+bool     captureOn         = false;
+uint8_t  captureLastRelays = 0;
+uint16_t captureSeq        = 0;
+
+// An input that couldn't be recorded whole. The replayer suspends comparison
+// until the next snapshot rather than report a bogus controller mismatch.
+void captureDropped(uint8_t type, const char* what) {
+  captureRecord(CAP_DROPPED, &type, 1, what, strlen(what) + 1);
+}
+
+void captureRecord(uint8_t type, const void* a, size_t alen, const void* b, size_t blen) {
+  if (alen + blen > 0xFFFF) {
+    // MQTT and web records both start with a NUL-terminated topic / path
+    bool named = (type == CAP_MQTT || type == CAP_WEB);
+    if (type != CAP_DROPPED) captureDropped(type, named ? (const char*)a : "");
+    return;
+  }
+  uint32_t t = millis();
+  uint16_t len = alen + blen;
+  uint16_t seq = captureSeq++;
+  uint8_t hdr[11] = { 0xA5, 0x5A, type, (uint8_t)seq, (uint8_t)(seq >> 8),
+                      (uint8_t)t, (uint8_t)(t >> 8), (uint8_t)(t >> 16), (uint8_t)(t >> 24),
+                      (uint8_t)len, (uint8_t)(len >> 8) };
+  uint8_t sum = 0;
+  for (int i = 2; i < 11; i++) sum += hdr[i];
+  for (size_t i = 0; i < alen; i++) sum += ((const uint8_t*)a)[i];
+  for (size_t i = 0; i < blen; i++) sum += ((const uint8_t*)b)[i];
+
+  Serial.write(hdr, sizeof(hdr));
+  if (alen) Serial.write((const uint8_t*)a, alen);
+  if (blen) Serial.write((const uint8_t*)b, blen);
+  Serial.write(sum);
+}
+
+void captureStart() {
+  StaticJsonDocument<512> d;
+  d["mode"]            = hvacModeStr;
+  d["target_temp_f"]   = targetTempF;
+  d["temp_f"]          = currentTempF;
+  d["humidity"]        = humidity;
+  d["min_on_s"]        = MIN_ON_SEC;
+  d["min_off_s"]       = MIN_OFF_SEC;
+  d["deadband_f"]      = DEADBAND_F;
+  d["stage2_delta_f"]  = STAGE2_DELTA_F;
+  d["stage2_delay_s"]  = STAGE2_DELAY_SEC;
+  d["fan_with_heat"]   = FAN_WITH_HEAT;
+  d["relays"]          = relayBits();
+  d["calls"]           = callBits();
+  d["y1_last_change"]  = y1_last_change;
+  d["w_call_start"]    = w_call_start;
+  char buf[512];
+  size_t n = serializeJson(d, buf, sizeof(buf));
+
+  captureOn = true;
+  captureLastRelays = relayBits();
+  captureSeq = 0;
+  captureRecord(CAP_SNAPSHOT, buf, n);
+}
+
+// Called at the end of applyOutputs(): log only actual transitions
+void captureRelays() {
+  if (!captureOn) return;
+  uint8_t r = relayBits();
+  if (r == captureLastRelays) return;
+  captureLastRelays = r;
+  captureRecord(CAP_RELAYS, &r, 1);
+}
+
+void captureWeb(const char* path) {
+  if (!captureOn) return;
+  char buf[512];
+  size_t n = 0;
+  bool fits = true;
+  auto put = [&](const char* v) {   // copy including the terminating NUL
+    size_t l = strlen(v) + 1;
+    if (n + l <= sizeof(buf)) { memcpy(buf + n, v, l); n += l; }
+    else fits = false;
+  };
+  put(path);
+  for (int i = 0; i < server.args(); i++) {
+    put(server.argName(i).c_str());
+    put(server.arg(i).c_str());
+  }
+  if (fits) captureRecord(CAP_WEB, buf, n);
+  else      captureDropped(CAP_WEB, path);
+}
+
+// --------------------- Runtime analytics ---------------------
+// Per-relay on-time and start counts over sliding 1 h / 24 h / 7 d windows,
+// updated from applyOutputs() and published on t_stats. Each window is a ring
+// of fixed-width buckets with running totals, so an update touches only the
+// buckets it crosses. Window edges have bucket resolution (1 min / 15 min / 1 h).
+constexpr int RUN_CH = 4;   // relayBits() order: G, W1, W2, Y1
+enum RunChannel { RC_G = 0, RC_W1, RC_W2, RC_Y1 };
+
+struct RunBucket {
+  uint16_t on_s[RUN_CH];
+  uint16_t starts[RUN_CH];
+  uint16_t y1_cycles;    // compressor cycles that ended in this bucket
+  uint32_t y1_cycle_s;   // their full lengths, including time before the bucket
+};
+
+template <uint16_t N, uint16_t WIDTH_S>
+struct RunWindow {
+  static constexpr uint32_t SPAN_S = (uint32_t)N * WIDTH_S;
+  RunBucket b[N] = {};
+  uint32_t  onS[RUN_CH]    = {0};   // totals over the ring
+  uint32_t  starts[RUN_CH] = {0};
+  uint32_t  y1Cycles = 0, y1CycleS = 0;
+  uint32_t  cur = 0;                // absolute bucket number (t / WIDTH_S) of the newest bucket
+
+  void clear() {
+    memset(b, 0, sizeof(b)); memset(onS, 0, sizeof(onS)); memset(starts, 0, sizeof(starts));
+    y1Cycles = y1CycleS = 0;
+  }
+
+  // Make t's bucket the newest, evicting the ones that fall out of the window
+  void advance(uint32_t t) {
+    uint32_t nb = t / WIDTH_S;
+    if (nb <= cur) return;
+    if (nb - cur >= N) { clear(); cur = nb; return; }
+    while (cur < nb) {
+      RunBucket& e = b[++cur % N];
+      for (int c = 0; c < RUN_CH; c++) { onS[c] -= e.on_s[c]; starts[c] -= e.starts[c]; }
+      y1Cycles -= e.y1_cycles; y1CycleS -= e.y1_cycle_s;
+      e = RunBucket{};
+    }
+  }
+
+  // Credit [t0, t1) to every channel set in bits, split at bucket edges
+  void accrue(uint32_t t0, uint32_t t1, uint8_t bits) {
+    if (t1 - t0 > SPAN_S) t0 = t1 - SPAN_S;   // older time would be evicted anyway
+    while (bits && t0 < t1) {
+      uint32_t edge = (t0 / WIDTH_S + 1) * WIDTH_S;
+      uint32_t end  = edge < t1 ? edge : t1;
+      advance(t0);
+      RunBucket& k = b[cur % N];
+      for (int c = 0; c < RUN_CH; c++) {
+        if (bits & (1 << c)) { k.on_s[c] += end - t0; onS[c] += end - t0; }
+      }
+      t0 = end;
+    }
+    advance(t1);
+  }
+
+  void start(int c) { b[cur % N].starts[c]++; starts[c]++; }
+  void y1CycleEnd(uint32_t len) { b[cur % N].y1_cycles++; b[cur % N].y1_cycle_s += len; y1Cycles++; y1CycleS += len; }
+
+  // Seconds the totals actually cover (less than the span shortly after boot)
+  uint32_t covered(uint32_t t, uint32_t since) const {
+    uint32_t ring = SPAN_S - WIDTH_S + (t % WIDTH_S);
+    return (t - since < ring) ? t - since : ring;
+  }
+};
+
+RunWindow<60, 60>    run1h;     // 60 x 1 min
+RunWindow<96, 900>   run24h;    // 96 x 15 min
+RunWindow<168, 3600> run7d;     // 168 x 1 h
+uint32_t runSince    = 0;       // start of accounting (boot, or millis() wrap)
+uint32_t runLastT    = 0;
+uint8_t  runLastBits = 0;
+uint32_t runY1Start  = 0;       // start of the current compressor run
+
+// Accrue on-time up to now and count rising edges. Called from applyOutputs()
+// on every evaluation and from publishStats(), so gaps stay short.
+void statsUpdate(uint32_t now, uint8_t bits) {
+  if (now < runLastT) {   // millis() wrapped: restart the windows
+    run1h.clear(); run24h.clear(); run7d.clear();
+    run1h.cur = run24h.cur = run7d.cur = 0;
+    runSince = runLastT = runY1Start = now;
+  }
+  run1h.accrue(runLastT, now, runLastBits);
+  run24h.accrue(runLastT, now, runLastBits);
+  run7d.accrue(runLastT, now, runLastBits);
+
+  uint8_t rising = bits & ~runLastBits;
+  for (int c = 0; c < RUN_CH; c++) {
+    if (rising & (1 << c)) { run1h.start(c); run24h.start(c); run7d.start(c); }
+  }
+  // A compressor cycle counts, with its whole length, in the window it ends in
+  if (rising & (1 << RC_Y1)) runY1Start = now;
+  if (runLastBits & ~bits & (1 << RC_Y1)) {
+    uint32_t len = now - runY1Start;
+    run1h.y1CycleEnd(len); run24h.y1CycleEnd(len); run7d.y1CycleEnd(len);
+  }
+  runLastT = now;
+  runLastBits = bits;
+}
+
+template <uint16_t N, uint16_t W>
+void statsToJson(JsonDocument& d, const char* sfx, const RunWindow<N, W>& w, uint32_t now) {
+  float cov = w.covered(now, runSince);
+  if (cov < 1) cov = 1;
+  char key[24];
+  auto put = [&](const char* name, float v) {
+    snprintf(key, sizeof(key), "%s_%s", name, sfx);
+    d[key] = roundf(v * 10) / 10;
+  };
+  put("y1_cph",    w.starts[RC_Y1] * 3600.0f / cov);
+  put("y1_duty",   w.onS[RC_Y1] * 100.0f / cov);
+  put("w1_duty",   w.onS[RC_W1] * 100.0f / cov);
+  put("w2_duty",   w.onS[RC_W2] * 100.0f / cov);
+  put("fan_min",   w.onS[RC_G] / 60.0f);
+  put("y1_cycle_min", w.y1Cycles ? w.y1CycleS / 60.0f / w.y1Cycles : 0.0f);
+}
+
+void publishStats() {
+  uint32_t now = now_s();
+  statsUpdate(now, runLastBits);
+
+  StaticJsonDocument<1024> d;
+  statsToJson(d, "1h",  run1h,  now);
+  statsToJson(d, "24h", run24h, now);
+  statsToJson(d, "7d",  run7d,  now);
+  char buf[1024];
+  size_t n = serializeJson(d, buf, sizeof(buf));
+  mqtt.publish(t_stats.c_str(), (const uint8_t*)buf, n, true);
+}
+
+// One HA sensor per runtime metric and window, reading from t_stats
+void publishStatDiscovery(const char* metric, const char* window, const char* name,
+                          const char* unit, const char* dclass) {
+  String id = String(DEV_ID) + "_" + metric + "_" + window;
+
+  StaticJsonDocument<600> d;
+  d["name"] = String(DEV_NAME) + " " + name + " (" + window + ")";
+  d["uniq_id"] = id;
+  d["obj_id"] = id;
+  d["availability_topic"] = t_avail;
+  d["state_topic"] = t_stats;
+  d["value_template"] = String("{{ value_json.") + metric + "_" + window + " }}";
+  d["unit_of_measurement"] = unit;
+  if (dclass) d["device_class"] = dclass;
+  d["state_class"] = "measurement";
+
+  JsonObject dev = d.createNestedObject("device");
+  dev["name"] = DEV_NAME;
+  dev["manufacturer"] = "Waveshare";
+  dev["model"] = "ESP32-S3-Relay-6CH";
+  JsonArray ids = dev.createNestedArray("identifiers");
+  ids.add(DEV_ID);
+
+  String topic = String("homeassistant/sensor/armenda/") + id + "/config";
+  char buf[600];
+  size_t n = serializeJson(d, buf, sizeof(buf));
+  mqtt.publish(topic.c_str(), (const uint8_t*)buf, n, true);
+}
+
 // Enhanced discovery - includes climate + temperature/humidity sensors
 void publishDiscovery() {
   // Climate entity (your existing functionality)
@@ -228,6 +699,23 @@ void publishDiscovery() {
   mqtt.publish(t_disc_hum.c_str(), (const uint8_t*)hum_buf, hum_n, true);
 }
 
+// Runtime analytics sensors. Kept out of publishDiscovery() so its ~5 KB of
+// documents are off the stack first (this runs inside mqtt.loop()).
+void publishStatsDiscovery() {
+  static const struct { const char* metric; const char* name; const char* unit; const char* dclass; } STATS[] = {
+    { "y1_cph",       "Compressor Cycles per Hour", "cycles/h", nullptr    },
+    { "y1_duty",      "Compressor Duty",            "%",        nullptr    },
+    { "w1_duty",      "Heat Stage 1 Duty",          "%",        nullptr    },
+    { "w2_duty",      "Heat Stage 2 Duty",          "%",        nullptr    },
+    { "fan_min",      "Fan Runtime",                "min",      "duration" },
+    { "y1_cycle_min", "Avg Compressor Cycle",       "min",      "duration" },
+  };
+  static const char* WINDOWS[] = { "1h", "24h", "7d" };
+  for (const auto& st : STATS) {
+    for (const char* w : WINDOWS) publishStatDiscovery(st.metric, w, st.name, st.unit, st.dclass);
+  }
+}
+
 // --------------------- Control logic ---------------------
 void updateLed(bool wantY1, bool wantW1, bool wantW2, bool wantG, bool compressorBlocked) {
   if (hvacMode == M_OFF) { setLedOff(); return; }
@@ -297,8 +785,11 @@ void applyOutputs() {
   // Fan relay (on with cooling or explicit)
   bool final_G = want_G || want_Y1;
   setRelay(PIN_G, final_G);
+  g_on = final_G;
 
   updateLed(want_Y1, want_W1, want_W2, final_G, compressorBlocked);
+  captureRelays();
+  statsUpdate(now, relayBits());
 }
 
 // --------------------- Command handling ---------------------
@@ -326,13 +817,40 @@ void handleCmd(const JsonVariant& j) {
   if (j.containsKey("stage2_delay_s"))  STAGE2_DELAY_SEC = j["stage2_delay_s"].as<uint32_t>();
   if (j.containsKey("fan_with_heat"))   FAN_WITH_HEAT    = j["fan_with_heat"].as<bool>();
 
+  // Binary telemetry rate (0 disables)
+  if (j.containsKey("telemetry_ms")) {
+    uint32_t ms = j["telemetry_ms"].as<uint32_t>();
+    TELEMETRY_MS = (ms && ms < TELEMETRY_MIN_MS) ? TELEMETRY_MIN_MS : ms;
+    telemCfgValid = false;
+  }
+
+  // Deferred: publishing here would overwrite the MQTT buffer the parsed
+  // command still points into (see onMqtt)
+  if (j.containsKey("trace_stats")) {
+    if (strcmp(j["trace_stats"] | "", "reset") == 0) {
+      histCmdToRelay = LatencyHist(); histCmdToPublish = LatencyHist();
+      cmdUntimed = true; traceStatsPending = true;
+    } else if (j["trace_stats"].as<bool>()) {
+      traceStatsPending = true;
+    }
+  }
+
+  // Record inputs for host replay (see captureStart)
+  if (j.containsKey("capture")) {
+    cmdUntimed = true;
+    if (j["capture"].as<bool>()) captureStart();
+    else                         captureOn = false;
+  }
+
   // Open captive portal from HA (blocks until saved/timeout)
   if (j.containsKey("portal") && j["portal"].as<bool>()) {
+    cmdUntimed = true;
     runConfigPortal(false); // do not erase Wi-Fi, just open portal
   }
 
   // Factory Wi-Fi reset: forget credentials and reboot (will open portal on boot)
   if (j.containsKey("wifi_reset") && j["wifi_reset"].as<bool>()) {
+    cmdUntimed = true;
     WiFi.disconnect(true, true); // erase NVS Wi-Fi
     prefs.begin("thermo", false);
     prefs.putString("ha_ip", "");
@@ -348,22 +866,49 @@ void handleCmd(const JsonVariant& j) {
 
 // --------------------- MQTT callback ---------------------
 void onMqtt(char* topic, byte* payload, unsigned int len) {
+  if (captureOn) captureRecord(CAP_MQTT, topic, strlen(topic) + 1, payload, len);
+
   if (strcmp(topic, "homeassistant/status") == 0) {
     String v((char*)payload, len); v.trim();
-    if (v == "online") { publishDiscovery(); publishState(); }
+    if (v == "online") { publishDiscovery(); publishStatsDiscovery(); publishState(); publishStats(); }
     return;
   }
 
+  CmdTrace tr = {};
+  tr.rx_us = micros();
+
   String t(topic);
   if (t == t_ambient || t == t_cmd) {
     StaticJsonDocument<384> d;
     if (deserializeJson(d, payload, len)) return;
+    tr.parsed_us = micros();
+
+    // Copy the correlation id out now: payload points into the MQTT buffer,
+    // which publishState() reuses. Only string ids are traced.
+    bool traced = (t == t_cmd) && d["cid"].is<const char*>();
+    if (traced) {
+      strlcpy(tr.cid, d["cid"] | "", sizeof(tr.cid));
+      tr.hasTs = d.containsKey("ts");
+      tr.ts    = tr.hasTs ? d["ts"].as<long long>() : 0;
+    }
 
+    cmdUntimed = false;
     if (t == t_ambient) handleAmbient(d.as<JsonVariant>());
     else                handleCmd(d.as<JsonVariant>());
+    tr.handled_us = micros();
 
     applyOutputs();
+    tr.relay_us = micros();
+
     publishState();
+    tr.pub_us = micros();
+
+    if (t == t_cmd && !cmdUntimed) {
+      histCmdToRelay.add(tr.relay_us - tr.rx_us);
+      histCmdToPublish.add(tr.pub_us - tr.rx_us);
+    }
+    if (traced) publishTrace(tr);
+    if (traceStatsPending) { traceStatsPending = false; publishTraceStats(); }
   }
 }
 
@@ -386,8 +931,11 @@ void ensureMqtt() {
       mqtt.subscribe(t_cmd.c_str());
       mqtt.subscribe(t_ambient.c_str());
       mqtt.subscribe("homeassistant/status");
+      telemCfgValid = false;
       publishDiscovery();
+      publishStatsDiscovery();
       publishState();
+      publishStats();
     } else {
       delay(1200);
     }
@@ -518,6 +1066,10 @@ void handleRoot() {
   html += "Current: " + String(currentTempF, 1) + "°F | Humidity: " + String(humidity, 1) + "%<br>";
   html += "Outputs: Y1:" + String(y1_on ? "ON" : "OFF") + " W1:" + String(w1_on ? "ON" : "OFF") + 
           " W2:" + String(w2_on ? "ON" : "OFF") + "<br>";
+  html += "Cmd latency (p50/p99): relay " + String(histCmdToRelay.quantileUpper(0.5f)) + "/" +
+          String(histCmdToRelay.quantileUpper(0.99f)) + "µs | publish " +
+          String(histCmdToPublish.quantileUpper(0.5f)) + "/" + String(histCmdToPublish.quantileUpper(0.99f)) +
+          "µs (n=" + String(histCmdToPublish.n) + ")<br>";
   html += "WiFi: " + WiFi.SSID() + " (" + WiFi.localIP().toString() + ") | Uptime: " + String(now_s()) + "s";
   html += "</div>";
 
@@ -610,6 +1162,7 @@ void handleConfig() {
 }
 
 void handleSetMode() {
+  captureWeb("/setmode");
   if (server.hasArg("mode")) {
     String m = server.arg("mode"); m.toLowerCase();
     if      (m == "off")       { hvacMode = M_OFF;      hvacModeStr = "off";       allOff(); setLedOff(); }
@@ -626,6 +1179,7 @@ void handleSetMode() {
 }
 
 void handleSetTemp() {
+  captureWeb("/settemp");
   if (server.hasArg("temp")) {
     targetTempF = server.arg("temp").toFloat();
     applyOutputs();
@@ -636,6 +1190,7 @@ void handleSetTemp() {
 }
 
 void handleSetSensors() {
+  captureWeb("/setsensors");
   if (server.hasArg("temp_f")) {
     currentTempF = server.arg("temp_f").toFloat();
   }
@@ -649,6 +1204,7 @@ void handleSetSensors() {
 }
 
 void handleSaveConfig() {
+  captureWeb("/saveconfig");
   if (server.hasArg("min_on_s")) MIN_ON_SEC = server.arg("min_on_s").toInt();
   if (server.hasArg("min_off_s")) MIN_OFF_SEC = server.arg("min_off_s").toInt();
   if (server.hasArg("deadband_f")) DEADBAND_F = server.arg("deadband_f").toFloat();
@@ -682,6 +1238,8 @@ void startWebServer() {
 
 // --------------------- Arduino lifecycle ---------------------
 void setup() {
+  Serial.begin(115200);
+
   // Relays
   pinMode(PIN_G,  OUTPUT);
   pinMode(PIN_W1, OUTPUT);
@@ -752,4 +1310,12 @@ void loop() {
   // Heartbeat for HA attributes
   static uint32_t t0 = 0;
   if (millis() - t0 > 5000) { t0 = millis(); publishState(); }
+
+  // Runtime analytics (values change slowly)
+  static uint32_t t2 = 0;
+  if (millis() - t2 > 60000) { t2 = millis(); publishStats(); }
+
+  // Opt-in high-rate binary telemetry
+  static uint32_t t1 = 0;
+  if (TELEMETRY_MS && millis() - t1 >= TELEMETRY_MS) { t1 = millis(); publishTelemetry(); }
 }
@@ -0,0 +1,282 @@
+// ===== Armenda Thermostat - host microbenchmarks (Linux) =====
+// Runs the firmware hot paths from main.cpp on a PC against the stubs in
+// tools/shim/ and reports, per case:
+//   ns_per_op     wall time per call (host CPU, so compare runs, not devices)
+//   allocs_per_op heap allocations per call (operator new)
+//   bytes_per_op  heap bytes requested per call
+//   stack_bytes   peak stack used by one call (painted-stack high-water mark)
+//   out_bytes     bytes published to MQTT / sent to the web client per call
+//
+// Build (ArduinoJson 6.x sources; PlatformIO keeps a copy under .pio/libdeps/):
+//   g++ -O2 -std=gnu++17 -Itools/shim -I<path-to>/ArduinoJson/src -o thermo_bench tools/bench.cpp
+//
+// Usage:
+//   ./thermo_bench [--out results.json] [--label <git-sha>] [--compare baseline.json]
+//                  [--filter <substring>] [--min-ms N]
+
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING 1
+#define ARDUINOJSON_ENABLE_ARDUINO_STREAM 0
+#define ARDUINOJSON_ENABLE_ARDUINO_PRINT  0
+#define ARDUINOJSON_ENABLE_PROGMEM        0
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <ucontext.h>
+#include <vector>
+
+#include "../main.cpp"
+
+// --------------------- Allocation counting ---------------------
+static bool          g_countAllocs = false;
+static unsigned long g_allocs      = 0;
+static unsigned long g_allocBytes  = 0;
+
+// Bytes produced by encode-only cases, which publish nothing
+static unsigned long g_encodedBytes = 0;
+
+// Kept out of line so GCC doesn't pair the inlined malloc/free with new/delete
+// call sites and warn (-Wmismatched-new-delete).
+#define BENCH_NOINLINE __attribute__((noinline))
+
+BENCH_NOINLINE void* operator new(size_t n) {
+  if (g_countAllocs) { g_allocs++; g_allocBytes += n; }
+  if (void* p = malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+BENCH_NOINLINE void* operator new[](size_t n) { return operator new(n); }
+BENCH_NOINLINE void  operator delete(void* p) noexcept { free(p); }
+BENCH_NOINLINE void  operator delete[](void* p) noexcept { free(p); }
+BENCH_NOINLINE void  operator delete(void* p, size_t) noexcept { free(p); }
+BENCH_NOINLINE void  operator delete[](void* p, size_t) noexcept { free(p); }
+
+// --------------------- Peak stack ---------------------
+// Runs fn on a private stack filled with a pattern and reports how deep it
+// was overwritten. Trampoline overhead is subtracted using an empty call.
+static std::function<void()> g_stackFn;
+static void stackTrampoline() { g_stackFn(); }
+
+static size_t rawStackUse(const std::function<void()>& fn) {
+  static std::vector<uint8_t> stack(512 * 1024);
+  memset(stack.data(), 0xA5, stack.size());
+  ucontext_t caller, callee;
+  getcontext(&callee);
+  callee.uc_stack.ss_sp   = stack.data();
+  callee.uc_stack.ss_size = stack.size();
+  callee.uc_link          = &caller;
+  g_stackFn = fn;
+  makecontext(&callee, stackTrampoline, 0);
+  swapcontext(&caller, &callee);
+  size_t untouched = 0;
+  while (untouched < stack.size() && stack[untouched] == 0xA5) untouched++;
+  return stack.size() - untouched;
+}
+
+static size_t stackUse(const std::function<void()>& fn) {
+  static size_t base = rawStackUse([] {});
+  size_t used = rawStackUse(fn);
+  return used > base ? used - base : 0;
+}
+
+// --------------------- Fixtures ---------------------
+static const char* MODE_NAMES[] = { "off", "heat", "cool", "heat_cool", "fan_only" };
+
+// Defaults from main.cpp, with time far enough past boot that compressor
+// min-off never blocks, so every mode exercises its run path.
+static void resetState() {
+  shim::virtualTime = true;
+  shim::virtualUs   = 3600ULL * 1000000ULL;
+  MIN_ON_SEC = 300; MIN_OFF_SEC = 300; DEADBAND_F = 0.8f;
+  STAGE2_DELTA_F = 2.0f; STAGE2_DELAY_SEC = 600; FAN_WITH_HEAT = false;
+  TELEMETRY_MS = 0; telemCfgValid = false;
+  hvacMode = M_OFF; hvacModeStr = "off"; hvacAction = "idle";
+  y1_on = w1_on = w2_on = g_on = false;
+  relayOut = 0;
+  y1_last_change = 0; w_call_start = 0;
+  targetTempF = 72.0f; currentTempF = 72.0f; humidity = 45.0f;
+}
+
+// Put the controller in a mode with active demand for that mode
+static void enterMode(Mode m) {
+  resetState();
+  hvacMode = m; hvacModeStr = MODE_NAMES[m];
+  if (m == M_HEAT)                      currentTempF = 68.0f;
+  if (m == M_COOL || m == M_HEATCOOL)   currentTempF = 76.0f;
+  applyOutputs();
+}
+
+struct Case {
+  std::string           name;
+  std::function<void()> setup;
+  std::function<void()> op;
+};
+
+struct Result {
+  std::string name;
+  double ns_per_op, allocs_per_op, bytes_per_op, out_bytes;
+  size_t stack_bytes;
+};
+
+static Result run(const Case& c, double minMs) {
+  Result r{ c.name, 0, 0, 0, 0, 0 };
+  c.setup();
+  for (int i = 0; i < 50; i++) c.op();   // warm up
+
+  // Allocations and output size over a fixed batch
+  const int batch = 200;
+  c.setup();
+  unsigned long out0 = mqtt.publishedBytes + g_encodedBytes;
+  server.lastBody = String();
+  g_allocs = g_allocBytes = 0;
+  g_countAllocs = true;
+  for (int i = 0; i < batch; i++) c.op();
+  g_countAllocs = false;
+  r.allocs_per_op = (double)g_allocs / batch;
+  r.bytes_per_op  = (double)g_allocBytes / batch;
+  r.out_bytes     = (double)(mqtt.publishedBytes + g_encodedBytes - out0) / batch + server.lastBody.length();
+
+  // Timing: double the batch until it runs for at least minMs
+  c.setup();
+  using clk = std::chrono::steady_clock;
+  for (unsigned long n = 64;; n *= 2) {
+    auto t0 = clk::now();
+    for (unsigned long i = 0; i < n; i++) c.op();
+    double ns = std::chrono::duration<double, std::nano>(clk::now() - t0).count();
+    if (ns >= minMs * 1e6 || n >= (1UL << 26)) { r.ns_per_op = ns / n; break; }
+  }
+
+  c.setup();
+  r.stack_bytes = stackUse(c.op);
+  return r;
+}
+
+// onMqtt() parses in place, so every call gets a fresh copy of the payload
+static void deliver(const char* topic, const std::string& payload) {
+  char t[128];
+  strlcpy(t, topic, sizeof(t));
+  std::vector<uint8_t> p(payload.begin(), payload.end());
+  onMqtt(t, p.data(), (unsigned)p.size());
+}
+
+static std::vector<Case> buildCases() {
+  std::vector<Case> cases;
+
+  for (int m = M_OFF; m <= M_FANONLY; m++) {
+    Mode mode = (Mode)m;
+    auto setup = [mode] { enterMode(mode); };
+    std::string tag = MODE_NAMES[m];
+    cases.push_back({ "publishState/" + tag, setup, [] { publishState(); } });
+    cases.push_back({ "applyOutputs/" + tag, setup, [] { applyOutputs(); } });
+    cases.push_back({ "handleRoot/" + tag,   setup, [] { handleRoot(); } });
+  }
+
+  auto idle = [] { enterMode(M_HEATCOOL); };
+  cases.push_back({ "publishTelemetry/steady",      idle, [] { telemCfgValid = true; publishTelemetry(); } });
+  cases.push_back({ "publishTelemetry/with_config", idle, [] { telemCfgValid = false; publishTelemetry(); } });
+
+  // State encoding alone, JSON (publishState) vs CBOR (publishTelemetry)
+  cases.push_back({ "encode/state_json",            idle, [] {
+    char buf[512]; g_encodedBytes += encodeState(buf, sizeof(buf)); } });
+  cases.push_back({ "encode/telemetry_cbor",        idle, [] {
+    uint8_t buf[96]; telemCfgValid = true; g_encodedBytes += encodeTelemetry(buf, sizeof(buf)); } });
+  cases.push_back({ "encode/telemetry_cbor_config", idle, [] {
+    uint8_t buf[96]; telemCfgValid = false; g_encodedBytes += encodeTelemetry(buf, sizeof(buf)); } });
+
+  cases.push_back({ "publishDiscovery",             idle, [] { publishDiscovery(); } });
+  cases.push_back({ "publishStatsDiscovery",        idle, [] { publishStatsDiscovery(); } });
+  cases.push_back({ "publishStats",                 idle, [] { publishStats(); } });
+  cases.push_back({ "handleConfig",                 idle, [] { handleConfig(); } });
+
+  // onMqtt() end to end (parse + handle + applyOutputs + publishState)
+  static const std::map<std::string, std::pair<String*, std::string>> payloads = {
+    { "cmd_mode",     { &t_cmd,     "{\"mode\":\"heat\"}" } },
+    { "cmd_setpoint", { &t_cmd,     "{\"mode\":\"cool\",\"target_temp_f\":71.5}" } },
+    { "cmd_traced",   { &t_cmd,     "{\"target_temp_f\":71.5,\"cid\":\"c-0123456789\",\"ts\":1760000000300}" } },
+    { "cmd_tunables", { &t_cmd,     "{\"min_on_s\":420,\"min_off_s\":420,\"deadband_f\":1.0,"
+                                    "\"stage2_delta_f\":2.5,\"stage2_delay_s\":900,\"fan_with_heat\":true}" } },
+    { "ambient",      { &t_ambient, "{\"temp_f\":73.2,\"humidity\":41.5}" } },
+  };
+  for (const auto& kv : payloads) {
+    const String* topic = kv.second.first;
+    std::string body = kv.second.second;
+    cases.push_back({ "onMqtt/" + kv.first + "/" + std::to_string(body.size()) + "B", idle,
+                      [topic, body] { deliver(topic->c_str(), body); } });
+  }
+  cases.push_back({ "onMqtt/ha_online", idle, [] { deliver("homeassistant/status", "online"); } });
+
+  return cases;
+}
+
+// --------------------- Result files ---------------------
+// One result object per line so files diff cleanly and parse without a JSON library.
+static void writeResults(const char* path, const char* label, const std::vector<Result>& rs) {
+  FILE* f = fopen(path, "w");
+  if (!f) { perror(path); return; }
+  fprintf(f, "{\"label\":\"%s\",\"results\":[\n", label);
+  for (size_t i = 0; i < rs.size(); i++) {
+    const Result& r = rs[i];
+    fprintf(f, "{\"name\":\"%s\",\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f,"
+               "\"stack_bytes\":%zu,\"out_bytes\":%.1f}%s\n",
+            r.name.c_str(), r.ns_per_op, r.allocs_per_op, r.bytes_per_op, r.stack_bytes, r.out_bytes,
+            i + 1 < rs.size() ? "," : "");
+  }
+  fprintf(f, "]}\n");
+  fclose(f);
+}
+
+static std::map<std::string, Result> readResults(const char* path) {
+  std::map<std::string, Result> out;
+  FILE* f = fopen(path, "r");
+  if (!f) { perror(path); return out; }
+  char line[512], name[160];
+  Result r{};
+  while (fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "{\"name\":\"%159[^\"]\",\"ns_per_op\":%lf,\"allocs_per_op\":%lf,\"bytes_per_op\":%lf,"
+                     "\"stack_bytes\":%zu,\"out_bytes\":%lf",
+               name, &r.ns_per_op, &r.allocs_per_op, &r.bytes_per_op, &r.stack_bytes, &r.out_bytes) == 6) {
+      r.name = name;
+      out[name] = r;
+    }
+  }
+  fclose(f);
+  return out;
+}
+
+int main(int argc, char** argv) {
+  const char* outPath = nullptr;
+  const char* label   = "";
+  const char* compare = nullptr;
+  const char* filter  = nullptr;
+  double      minMs   = 200;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if      (!strcmp(argv[i], "--out"))     outPath = argv[i + 1];
+    else if (!strcmp(argv[i], "--label"))   label   = argv[i + 1];
+    else if (!strcmp(argv[i], "--compare")) compare = argv[i + 1];
+    else if (!strcmp(argv[i], "--filter"))  filter  = argv[i + 1];
+    else if (!strcmp(argv[i], "--min-ms"))  minMs   = atof(argv[i + 1]);
+    else { fprintf(stderr, "unknown option %s\n", argv[i]); return 2; }
+  }
+
+  std::map<std::string, Result> base;
+  if (compare) base = readResults(compare);
+
+  printf("%-34s %12s %8s %10s %8s %8s%s\n", "case", "ns/op", "allocs", "heap B", "stack B", "out B",
+         compare ? "   vs base" : "");
+  std::vector<Result> results;
+  for (const Case& c : buildCases()) {
+    if (filter && c.name.find(filter) == std::string::npos) continue;
+    Result r = run(c, minMs);
+    results.push_back(r);
+    printf("%-34s %12.1f %8.2f %10.1f %8zu %8.1f", r.name.c_str(), r.ns_per_op, r.allocs_per_op,
+           r.bytes_per_op, r.stack_bytes, r.out_bytes);
+    auto it = base.find(r.name);
+    if (it != base.end() && it->second.ns_per_op > 0)
+      printf("   %+6.1f%%", 100.0 * (r.ns_per_op / it->second.ns_per_op - 1.0));
+    printf("\n");
+  }
+
+  if (outPath) writeResults(outPath, label, results);
+  return 0;
+}
@@ -0,0 +1,231 @@
+// ===== Armenda Thermostat - capture replayer (Linux) =====
+// Feeds a capture log (see captureStart() in main.cpp) back through the
+// controller logic from main.cpp in virtual time, and checks before every
+// input that the replayed relay outputs match the last ones the device recorded.
+//
+// Capture:
+//   mosquitto_pub -h <broker> -t thermo/main_thermostat/cmd -m '{"capture":true}'
+//   stty -F /dev/ttyACM0 raw && cat /dev/ttyACM0 > capture.bin
+//
+// Build (same shims and ArduinoJson as tools/bench.cpp):
+//   g++ -O2 -std=gnu++17 -Itools/shim -I<path-to>/ArduinoJson/src -o thermo_replay tools/replay.cpp
+//
+// Usage:
+//   ./thermo_replay capture.bin [-v]
+// Exit status is 1 if the relays ever differ, so it can gate a firmware change,
+// and 3 if none differ but the capture is incomplete: an input too large to
+// record, or records lost on the serial link (sequence gap or corrupt bytes).
+// Comparison is suspended from such a point until the next snapshot. A partial
+// record at the very end (capture stopped mid-write) only skips the final check.
+
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING 1
+#define ARDUINOJSON_ENABLE_ARDUINO_STREAM 0
+#define ARDUINOJSON_ENABLE_ARDUINO_PRINT  0
+#define ARDUINOJSON_ENABLE_PROGMEM        0
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../main.cpp"
+
+struct Record {
+  uint8_t              type;
+  uint16_t             seq;
+  uint64_t             t_ms;   // device millis(), unwrapped across 32-bit rollover
+  std::vector<uint8_t> data;
+  uint32_t             lost;   // records missing right before this one (0 if none;
+                               // at least 1 if only corrupt bytes were seen)
+};
+
+// Scan for A5 5A frames; bytes that don't form a valid frame (serial noise,
+// truncated tail) are skipped and counted. Bytes skipped after the first frame,
+// or a break in seq, mark the next frame as following a loss.
+static std::vector<Record> readLog(const char* path, unsigned long& skipped, bool& partialTail) {
+  std::vector<Record> out;
+  std::vector<uint8_t> buf;
+  FILE* f = fopen(path, "rb");
+  if (!f) { perror(path); return out; }
+  uint8_t chunk[65536];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) buf.insert(buf.end(), chunk, chunk + n);
+  fclose(f);
+
+  uint64_t wraps = 0;
+  uint32_t lastT = 0;
+  size_t i = 0;
+  unsigned long junk = 0;   // skipped since the last good frame
+  skipped = 0;
+  while (i + 12 <= buf.size()) {
+    if (buf[i] != 0xA5 || buf[i + 1] != 0x5A) { i++; junk++; continue; }
+    const uint8_t* h = &buf[i];
+    uint16_t seq = h[3] | h[4] << 8;
+    uint32_t t   = h[5] | h[6] << 8 | h[7] << 16 | (uint32_t)h[8] << 24;
+    uint16_t len = h[9] | h[10] << 8;
+    if (i + 12 + len > buf.size()) { i++; junk++; continue; }
+    uint8_t sum = 0;
+    for (size_t k = 2; k < 11u + len; k++) sum += h[k];
+    if (sum != h[11 + len]) { i++; junk++; continue; }
+
+    uint32_t lost = 0;
+    if (!out.empty()) {
+      uint16_t want = out.back().seq + 1;
+      if (h[2] == CAP_SNAPSHOT) lost = 0;                 // restarts seq and state anyway
+      else if (seq != want)     lost = (uint16_t)(seq - want);
+      else if (junk)            lost = 1;                 // damaged frame, seq resumed
+      if (t < lastT && lastT - t > 0x80000000u) wraps++;
+    }
+    skipped += junk; junk = 0;
+    lastT = t;
+    out.push_back({ h[2], seq, (wraps << 32) | t, std::vector<uint8_t>(h + 11, h + 11 + len), lost });
+    i += 12 + len;
+  }
+  junk += buf.size() - i;
+  partialTail = !out.empty() && junk;
+  skipped += junk;
+  return out;
+}
+
+static std::string relayNames(uint8_t bits) {
+  std::string s;
+  if (bits & 1) s += "G ";
+  if (bits & 2) s += "W1 ";
+  if (bits & 4) s += "W2 ";
+  if (bits & 8) s += "Y1 ";
+  if (s.empty()) return "-";
+  s.pop_back();
+  return s;
+}
+
+static void applySnapshot(const Record& r) {
+  StaticJsonDocument<512> d;
+  std::vector<uint8_t> copy(r.data);
+  if (deserializeJson(d, copy.data(), copy.size())) { fprintf(stderr, "bad snapshot record\n"); return; }
+  handleCmd(d.as<JsonVariant>());
+  handleAmbient(d.as<JsonVariant>());
+  // Pins and controller calls separately: after allOff() they can disagree
+  uint8_t pins   = d["relays"].as<uint8_t>();
+  uint8_t calls  = d.containsKey("calls") ? d["calls"].as<uint8_t>() : pins;
+  g_on           = calls & 1;
+  w1_on          = calls & 2;
+  w2_on          = calls & 4;
+  y1_on          = calls & 8;
+  y1_last_change = d["y1_last_change"].as<uint32_t>();
+  w_call_start   = d["w_call_start"].as<uint32_t>();
+  setRelay(PIN_G, pins & 1); setRelay(PIN_W1, pins & 2); setRelay(PIN_W2, pins & 4); setRelay(PIN_Y1, pins & 8);
+}
+
+static void replayWeb(const Record& r) {
+  // path \0 name \0 value \0 ...
+  std::vector<std::string> parts;
+  std::string cur;
+  for (uint8_t c : r.data) { if (c) cur += (char)c; else { parts.push_back(cur); cur.clear(); } }
+  if (parts.empty()) return;
+  server.clearArgs();
+  for (size_t k = 1; k + 1 < parts.size(); k += 2) server.setArg(parts[k].c_str(), String(parts[k + 1].c_str()));
+  if (!server.dispatch(parts[0].c_str())) fprintf(stderr, "unknown web route %s\n", parts[0].c_str());
+}
+
+static void replayMqtt(const Record& r) {
+  const uint8_t* nul = (const uint8_t*)memchr(r.data.data(), 0, r.data.size());
+  if (!nul) return;
+  std::vector<char>    topic(r.data.data(), nul + 1);
+  std::vector<uint8_t> payload(nul + 1, r.data.data() + r.data.size());
+  payload.push_back(0);  // onMqtt() gets len; the spare byte keeps data() valid when empty
+  onMqtt(topic.data(), payload.data(), (unsigned)payload.size() - 1);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) { fprintf(stderr, "usage: %s capture.bin [-v]\n", argv[0]); return 2; }
+  bool verbose = argc > 2 && !strcmp(argv[2], "-v");
+
+  unsigned long skipped = 0;
+  bool partialTail = false;
+  std::vector<Record> recs = readLog(argv[1], skipped, partialTail);
+
+  shim::virtualTime = true;
+  startWebServer();   // registers the POST routes with the shim
+
+  unsigned long counts[256] = {0};
+  unsigned long recorded = 0, replayed = 0, mismatches = 0, dropped = 0, gaps = 0, lostRecs = 0;
+  bool     synced   = false;        // inputs before the first snapshot can't be replayed
+  bool     diverged = false;        // already reported, waiting for the two to agree again
+  uint8_t  repBits  = 0;            // replayed relay outputs
+  uint8_t  devBits  = 0;            // last relay outputs the device recorded
+
+  // The device writes its 'R' record before it reads the next input, so by
+  // then both sides have settled. One report per divergence, not per record.
+  auto compare = [&](uint64_t t) {
+    if (repBits == devBits) {
+      if (diverged && verbose) printf("t=%.3fs relays agree again [%s]\n", t / 1000.0, relayNames(devBits).c_str());
+      diverged = false;
+      return;
+    }
+    if (diverged) return;
+    diverged = true;
+    mismatches++;
+    if (verbose || mismatches <= 20)
+      printf("MISMATCH t=%.3fs relays differ: device [%s] replay [%s]\n", t / 1000.0,
+             relayNames(devBits).c_str(), relayNames(repBits).c_str());
+  };
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (const Record& r : recs) {
+    counts[r.type]++;
+    shim::virtualUs = r.t_ms * 1000ULL;
+
+    if (r.lost && r.type != CAP_SNAPSHOT) {
+      gaps++; lostRecs += r.lost;
+      if (synced)
+        printf("LOST t=%.3fs %u record(s) missing before seq %u; comparison suspended until next snapshot\n",
+               r.t_ms / 1000.0, r.lost, r.seq);
+      synced = false;
+    }
+
+    if (r.type == CAP_SNAPSHOT) {
+      if (synced) compare(r.t_ms);
+      applySnapshot(r);
+      synced = true; diverged = false;
+      repBits = devBits = relayBits();
+      applyOutputs();   // the device runs it right after the capture command
+    } else if (r.type == CAP_DROPPED) {
+      dropped++;
+      const char* what = r.data.size() > 1 ? (const char*)&r.data[1] : "";
+      printf("DROPPED t=%.3fs %c input %.*s not captured; comparison suspended until next snapshot\n",
+             r.t_ms / 1000.0, r.data.empty() ? '?' : r.data[0], (int)strnlen(what, r.data.size() - 1), what);
+      synced = false;
+      continue;
+    } else if (!synced) {
+      continue;
+    } else if (r.type == CAP_RELAYS) {
+      recorded++;
+      devBits = r.data.empty() ? 0 : r.data[0];
+      continue;
+    } else {
+      compare(r.t_ms);
+      if      (r.type == CAP_MQTT) replayMqtt(r);
+      else if (r.type == CAP_WEB)  replayWeb(r);
+      else continue;
+    }
+
+    uint8_t bits = relayBits();
+    if (bits != repBits) {
+      replayed++;
+      if (verbose) printf("t=%.3fs replay [%s] -> [%s]\n", r.t_ms / 1000.0,
+                          relayNames(repBits).c_str(), relayNames(bits).c_str());
+      repBits = bits;
+    }
+  }
+  // A partial last record may be the device's 'R' for the last input
+  if (synced && !recs.empty() && !partialTail) compare(recs.back().t_ms);
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  double span = recs.size() > 1 ? (recs.back().t_ms - recs.front().t_ms) / 1000.0 : 0;
+  printf("records: %zu (snapshot %lu, mqtt %lu, web %lu, relays %lu), skipped bytes: %lu%s\n",
+         recs.size(), counts[CAP_SNAPSHOT], counts[CAP_MQTT], counts[CAP_WEB], counts[CAP_RELAYS], skipped,
+         partialTail ? " (partial last record)" : "");
+  printf("virtual span: %.1f s, wall: %.3f s, speedup: %.0fx\n", span, wall, wall > 0 ? span / wall : 0);
+  printf("relay transitions: recorded %lu, replayed %lu, mismatches %lu, dropped inputs %lu, serial gaps %lu (%lu records)\n",
+         recorded, replayed, mismatches, dropped, gaps, lostRecs);
+  return mismatches ? 1 : (dropped || gaps) ? 3 : 0;
+}
@@ -0,0 +1,66 @@
+// ===== Host shim: Arduino core (Linux) =====
+// Just enough of the ESP32 Arduino API for main.cpp to compile and run on a
+// PC, for the host benchmark / replay tools. Not a general-purpose port.
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "WString.h"
+
+typedef uint8_t byte;
+
+#define HIGH   1
+#define LOW    0
+#define OUTPUT 1
+#define INPUT  0
+
+namespace shim {
+  // When virtualTime is set, millis()/micros() return virtualUs instead of
+  // the host clock, so callers can step time deterministically.
+  inline bool     virtualTime = false;
+  inline uint64_t virtualUs   = 0;
+  inline uint8_t  pinLevel[64] = {0};
+
+  inline uint64_t hostUs() {
+    static const auto t0 = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - t0).count();
+  }
+  inline uint64_t nowUs() { return virtualTime ? virtualUs : hostUs(); }
+}
+
+inline unsigned long micros() { return (unsigned long)(uint32_t)shim::nowUs(); }
+inline unsigned long millis() { return (unsigned long)(uint32_t)(shim::nowUs() / 1000); }
+inline void delay(unsigned long ms) { if (shim::virtualTime) shim::virtualUs += ms * 1000ULL; }
+
+inline void pinMode(int, int) {}
+inline void digitalWrite(int pin, int v) { if (pin >= 0 && pin < 64) shim::pinLevel[pin] = v ? HIGH : LOW; }
+inline int  digitalRead(int pin)         { return (pin >= 0 && pin < 64) ? shim::pinLevel[pin] : LOW; }
+
+// glibc < 2.38 has no strlcpy
+inline size_t shim_strlcpy(char* dst, const char* src, size_t size) {
+  size_t n = strlen(src);
+  if (size) { size_t c = n < size - 1 ? n : size - 1; memcpy(dst, src, c); dst[c] = 0; }
+  return n;
+}
+#define strlcpy shim_strlcpy
+
+// Serial console; output is discarded unless a sink is installed
+struct HardwareSerial {
+  void (*sink)(const uint8_t* data, size_t len) = nullptr;
+  void   begin(unsigned long) {}
+  size_t write(uint8_t b)                      { return write(&b, 1); }
+  size_t write(const uint8_t* d, size_t len)   { if (sink) sink(d, len); return len; }
+};
+inline HardwareSerial Serial;
+
+struct EspClass {
+  void restart() { fprintf(stderr, "shim: ESP.restart() ignored\n"); }
+};
+inline EspClass ESP;
@@ -0,0 +1,10 @@
+// ===== Host shim: ESPmDNS =====
+#pragma once
+
+#include <Arduino.h>
+
+struct MDNSResponder {
+  bool begin(const char*) { return true; }
+  void addService(const char*, const char*, uint16_t) {}
+};
+inline MDNSResponder MDNS;
@@ -0,0 +1,18 @@
+// ===== Host shim: Preferences (in-memory, not persisted) =====
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+
+class Preferences {
+ public:
+  bool     begin(const char*, bool) { return true; }
+  void     end() {}
+  String   getString(const char* k, const String& def) { auto it = s_.find(k); return it == s_.end() ? def : it->second; }
+  size_t   putString(const char* k, const String& v)   { s_[k] = v; return v.length(); }
+  uint16_t getUShort(const char* k, uint16_t def)      { auto it = u_.find(k); return it == u_.end() ? def : it->second; }
+  size_t   putUShort(const char* k, uint16_t v)        { u_[k] = v; return 2; }
+ private:
+  std::map<std::string, String>   s_;
+  std::map<std::string, uint16_t> u_;
+};
@@ -0,0 +1,42 @@
+// ===== Host shim: PubSubClient =====
+// Publishes go to an optional hook instead of a broker; the hook sees the
+// same topic/payload the device would send.
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+class PubSubClient {
+ public:
+  using PublishHook = void (*)(const char* topic, const uint8_t* payload, unsigned int len, bool retained);
+
+  explicit PubSubClient(WiFiClient&) {}
+
+  PubSubClient& setServer(const char*, uint16_t) { return *this; }
+  PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE) { cb_ = callback; return *this; }
+
+  bool connect(const char*, const char*, uint8_t, bool, const char*)                           { return true; }
+  bool connect(const char*, const char*, const char*, const char*, uint8_t, bool, const char*) { return true; }
+  bool connected() { return true; }
+  bool subscribe(const char*) { return true; }
+  bool loop() { return true; }
+
+  bool publish(const char* topic, const char* payload, bool retained) {
+    return publish(topic, (const uint8_t*)payload, (unsigned)strlen(payload), retained);
+  }
+  bool publish(const char* topic, const uint8_t* payload, unsigned int len, bool retained) {
+    published++; publishedBytes += len;
+    if (hook) hook(topic, payload, len, retained);
+    return true;
+  }
+
+  PublishHook   hook = nullptr;
+  unsigned long published = 0;
+  unsigned long publishedBytes = 0;
+
+ private:
+  std::function<void(char*, uint8_t*, unsigned int)> cb_;
+};
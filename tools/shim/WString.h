@@ -0,0 +1,69 @@
+// ===== Host shim: Arduino String =====
+// Backed by std::string. Note: allocation counts differ from the device,
+// whose String has a smaller inline buffer and grows with realloc().
+#pragma once
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+class String {
+ public:
+  String() = default;
+  String(const char* s)               { if (s) s_ = s; }
+  String(const char* s, unsigned len) { if (s) s_.assign(s, len); }
+  String(const std::string& s) : s_(s) {}
+  explicit String(char c)             : s_(1, c) {}
+  explicit String(int v)              : s_(std::to_string(v)) {}
+  explicit String(unsigned v)         : s_(std::to_string(v)) {}
+  explicit String(long v)             : s_(std::to_string(v)) {}
+  explicit String(unsigned long v)    : s_(std::to_string(v)) {}
+  explicit String(float v, unsigned char decimals = 2)  { fmt(v, decimals); }
+  explicit String(double v, unsigned char decimals = 2) { fmt(v, decimals); }
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned    length() const { return (unsigned)s_.size(); }
+  void        reserve(unsigned n) { s_.reserve(n); }
+
+  bool concat(const char* s)     { if (!s) return false; s_ += s; return true; }
+  bool concat(const String& s)   { s_ += s.s_; return true; }
+  bool concat(char c)            { s_ += c; return true; }
+  String& operator+=(const char* s)   { concat(s); return *this; }
+  String& operator+=(const String& s) { concat(s); return *this; }
+  String& operator+=(char c)          { concat(c); return *this; }
+
+  // ArduinoJson's String writer resets the target with a null pointer
+  String& operator=(const char* s) { if (s) s_ = s; else s_.clear(); return *this; }
+
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* o)   const { return o && s_ == o; }
+  bool operator!=(const String& o) const { return !(*this == o); }
+  bool operator!=(const char* o)   const { return !(*this == o); }
+  char operator[](unsigned i)      const { return i < s_.size() ? s_[i] : 0; }
+
+  void  toLowerCase() { for (auto& c : s_) c = (char)tolower((unsigned char)c); }
+  void  trim() {
+    size_t b = s_.find_first_not_of(" \t\r\n"), e = s_.find_last_not_of(" \t\r\n");
+    s_ = (b == std::string::npos) ? std::string() : s_.substr(b, e - b + 1);
+  }
+  long  toInt()   const { return atol(s_.c_str()); }
+  float toFloat() const { return (float)atof(s_.c_str()); }
+
+  friend String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+  friend String operator+(const String& a, const char* b)   { String r(a); r += b; return r; }
+  friend String operator+(const char* a, const String& b)   { String r(a); r += b; return r; }
+  friend String operator+(const String& a, char b)          { String r(a); r += b; return r; }
+
+ private:
+  void fmt(double v, unsigned char decimals) {
+    char buf[48]; snprintf(buf, sizeof(buf), "%.*f", decimals, v); s_ = buf;
+  }
+  std::string s_;
+};
+
+// Referenced by ArduinoJson's string adapters; our operator+ returns String.
+class StringSumHelper : public String {
+ public:
+  using String::String;
+};
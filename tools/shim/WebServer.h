@@ -0,0 +1,48 @@
+// ===== Host shim: WebServer =====
+// Request args are set by the caller (setArg) before invoking a handler;
+// the last response is kept in lastCode / lastBody.
+#pragma once
+
+#include <Arduino.h>
+#include <iterator>
+#include <map>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_POST };
+
+class WebServer {
+ public:
+  typedef void (*Handler)();
+
+  explicit WebServer(int) {}
+  void on(const char* path, Handler h)             { routes_[path] = h; }
+  void on(const char* path, HTTPMethod, Handler h) { routes_[path] = h; }
+  void begin() {}
+  void handleClient() {}
+
+  bool   hasArg(const char* name) const { return args_.count(name) != 0; }
+  String arg(const char* name) const    { auto it = args_.find(name); return it == args_.end() ? String() : it->second; }
+  int    args() const { return (int)args_.size(); }
+  String argName(int i) const { auto it = std::next(args_.begin(), i); return String(it->first); }
+  String arg(int i) const     { return std::next(args_.begin(), i)->second; }
+  void   setArg(const char* name, const String& v) { args_[name] = v; }
+  void   clearArgs() { args_.clear(); }
+
+  void sendHeader(const char*, const String&) {}
+  void send(int code) { lastCode = code; lastBody = String(); }
+  void send(int code, const char*, const String& body) { lastCode = code; lastBody = body; }
+
+  // Invoke a registered route as if a request had arrived; false if unknown.
+  bool dispatch(const char* path) {
+    auto it = routes_.find(path);
+    if (it == routes_.end()) return false;
+    it->second();
+    return true;
+  }
+
+  int    lastCode = 0;
+  String lastBody;
+
+ private:
+  std::map<std::string, Handler> routes_;
+  std::map<std::string, String>  args_;
+};
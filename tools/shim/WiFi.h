@@ -0,0 +1,23 @@
+// ===== Host shim: WiFi =====
+#pragma once
+
+#include <Arduino.h>
+
+enum wl_status_t { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 };
+enum wifi_mode_t { WIFI_OFF = 0, WIFI_STA = 1 };
+
+struct IPAddress {
+  String toString() const { return "127.0.0.1"; }
+};
+
+struct WiFiClass {
+  wl_status_t status() const         { return WL_CONNECTED; }
+  bool        mode(wifi_mode_t)      { return true; }
+  void        begin()                {}
+  bool        disconnect(bool, bool) { return true; }
+  String      SSID() const           { return "host"; }
+  IPAddress   localIP() const        { return IPAddress(); }
+};
+inline WiFiClass WiFi;
+
+class WiFiClient {};
@@ -0,0 +1,23 @@
+// ===== Host shim: WiFiManager =====
+// The portal never opens on the host; autoConnect() reports failure.
+#pragma once
+
+#include <Arduino.h>
+
+class WiFiManagerParameter {
+ public:
+  explicit WiFiManagerParameter(const char*) {}
+  WiFiManagerParameter(const char*, const char*, const char* def, int, const char* = "") : value_(def) {}
+  const char* getValue() const { return value_.c_str(); }
+ private:
+  String value_;
+};
+
+class WiFiManager {
+ public:
+  void setConfigPortalBlocking(bool) {}
+  void setConfigPortalTimeout(unsigned long) {}
+  void setClass(const char*) {}
+  bool addParameter(WiFiManagerParameter*) { return true; }
+  bool autoConnect(const char*) { return false; }
+};
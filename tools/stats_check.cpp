@@ -0,0 +1,159 @@
+// ===== Armenda Thermostat - runtime analytics check (Linux) =====
+// Drives statsUpdate() from main.cpp with a seeded random relay trace (short
+// cycles mixed with long idle gaps) and checks it against a per-second
+// brute-force model over the same bucket-aligned window: from the start of
+// the oldest bucket in the ring (or the start of accounting, if later) up to
+// now. Both the raw 1 h / 24 h / 7 d totals and the values statsToJson()
+// publishes (duty, cycles per hour, fan minutes, cycle length) are compared.
+//
+// Two traces run: one from boot, and one straddling the 32-bit millis() wrap
+// (~49.7 days), where the device restarts its windows.
+//
+// Build (same shims and ArduinoJson as tools/bench.cpp):
+//   g++ -O2 -std=gnu++17 -Itools/shim -I<path-to>/ArduinoJson/src -o thermo_stats_check tools/stats_check.cpp
+//
+// Usage:
+//   ./thermo_stats_check [days] [seed]
+// Exit status is 1 on any mismatch.
+
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING 1
+#define ARDUINOJSON_ENABLE_ARDUINO_STREAM 0
+#define ARDUINOJSON_ENABLE_ARDUINO_PRINT  0
+#define ARDUINOJSON_ENABLE_PROGMEM        0
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../main.cpp"
+
+// Trace state, indexed by seconds since the start of the trace
+static std::vector<uint8_t>  perSecond;  // relay bits in effect during second s
+static std::vector<uint8_t>  rising;     // channels that started at second s
+static std::vector<uint32_t> y1Ended;    // length of the compressor cycle that ended at s (+1; 0 = none)
+static uint64_t traceStart;              // absolute seconds since boot of index 0
+static uint32_t since;                   // index where accounting (re)started
+
+static uint32_t deviceNow(uint32_t s) {
+  shim::virtualUs = (traceStart + s) * 1000000ULL;
+  return now_s();
+}
+
+// Published values are rounded to 0.1; allow for that plus float error
+static int near(const char* name, const char* key, uint32_t s, float got, double want) {
+  if (fabs(got - want) <= 0.05 + 1e-4 + 1e-6 * fabs(want)) return 0;
+  printf("MISMATCH %s t=%u %s %.2f (expect %.3f)\n", name, s, key, got, want);
+  return 1;
+}
+
+template <uint16_t N, uint16_t W>
+static int check(const char* name, const char* sfx, const RunWindow<N, W>& w, uint32_t s) {
+  // Window start in device seconds, mapped back to trace seconds
+  uint32_t now = deviceNow(s);
+  uint32_t nb  = now / W;
+  uint32_t ws  = nb >= N - 1u ? (nb - (N - 1u)) * W : 0;
+  uint32_t from = (now - ws <= s) ? s - (now - ws) : 0;
+  if (from < since) from = since;
+
+  uint32_t on[RUN_CH] = {0}, starts[RUN_CH] = {0}, cycles = 0;
+  uint64_t cycleS = 0;
+  for (uint32_t k = from; k <= s; k++) {
+    for (int c = 0; c < RUN_CH; c++) {
+      if (k < s && (perSecond[k] >> c & 1)) on[c]++;
+      if (rising[k] >> c & 1) starts[c]++;
+    }
+    if (y1Ended[k]) { cycles++; cycleS += y1Ended[k] - 1; }
+  }
+
+  int bad = 0;
+  for (int c = 0; c < RUN_CH; c++) {
+    if (on[c] == w.onS[c] && starts[c] == w.starts[c]) continue;
+    bad++;
+    printf("MISMATCH %s t=%u ch=%d on_s %u (expect %u) starts %u (expect %u)\n",
+           name, s, c, w.onS[c], on[c], w.starts[c], starts[c]);
+  }
+  if (cycles != w.y1Cycles || cycleS != w.y1CycleS) {
+    bad++;
+    printf("MISMATCH %s t=%u y1 cycles %u / %u s (expect %u / %llu s)\n",
+           name, s, w.y1Cycles, w.y1CycleS, cycles, (unsigned long long)cycleS);
+  }
+
+  StaticJsonDocument<384> d;
+  statsToJson(d, sfx, w, now);
+  double cov = s - from < 1 ? 1 : s - from;
+  char key[24];
+  auto got = [&](const char* metric) { snprintf(key, sizeof(key), "%s_%s", metric, sfx); return d[key].as<float>(); };
+  bad += near(name, "y1_cph",  s, got("y1_cph"),  starts[RC_Y1] * 3600.0 / cov);
+  bad += near(name, "y1_duty", s, got("y1_duty"), on[RC_Y1] * 100.0 / cov);
+  bad += near(name, "w1_duty", s, got("w1_duty"), on[RC_W1] * 100.0 / cov);
+  bad += near(name, "w2_duty", s, got("w2_duty"), on[RC_W2] * 100.0 / cov);
+  bad += near(name, "fan_min", s, got("fan_min"), on[RC_G] / 60.0);
+  bad += near(name, "y1_cycle_min", s, got("y1_cycle_min"), cycles ? cycleS / 60.0 / cycles : 0.0);
+  return bad;
+}
+
+// One trace of `days` starting `start` seconds after boot. Returns mismatches.
+static uint32_t runTrace(uint64_t start, uint32_t days, std::mt19937& rng, uint32_t& checks) {
+  uint32_t end = days * 86400;
+  traceStart = start;
+  perSecond.assign(end + 1, 0);
+  rising.assign(end + 1, 0);
+  y1Ended.assign(end + 1, 0);
+
+  // Fresh accounting at the trace start, as after boot
+  run1h.clear(); run24h.clear(); run7d.clear();
+  run1h.cur = run24h.cur = run7d.cur = 0;
+  runSince = runLastT = runY1Start = deviceNow(0);
+  runLastBits = 0;
+  since = 0;
+
+  uint32_t t = 0, mismatches = 0, y1Start = 0;
+  uint8_t  bits = 0;
+  while (true) {
+    // Mostly minutes between events, sometimes an idle gap of hours to days
+    uint32_t gap = (rng() % 20) ? 1 + rng() % 600 : 3600 + rng() % (3 * 86400);
+    if (t + gap > end) break;
+    for (uint32_t s = t; s < t + gap; s++) perSecond[s] = bits;
+
+    // millis() wrapped in the gap: the device drops everything before the
+    // first update after it, and runs in progress count from there
+    bool wrapped = deviceNow(t + gap) < deviceNow(t);
+    t += gap;
+    if (wrapped) {
+      since = y1Start = t;
+      printf("millis() wrap crossed at trace t=%u (device %u s -> %u s)\n", t, deviceNow(t - gap), deviceNow(t));
+    }
+
+    uint8_t next = bits;
+    if (rng() % 3) next = rng() & 0x0F;   // relay transition, as from applyOutputs()
+    rising[t] |= next & ~bits;
+    if (next & ~bits & (1 << RC_Y1)) y1Start = t;
+    if (bits & ~next & (1 << RC_Y1)) y1Ended[t] = t - y1Start + 1;
+    bits = next;
+    statsUpdate(deviceNow(t), bits);      // otherwise a periodic publishStats() tick
+
+    if (rng() % 3 == 0) {
+      checks++;
+      mismatches += check("1h", "1h", run1h, t) + check("24h", "24h", run24h, t) + check("7d", "7d", run7d, t);
+    }
+  }
+  return mismatches;
+}
+
+int main(int argc, char** argv) {
+  uint32_t days = argc > 1 ? atoi(argv[1]) : 40;
+  uint32_t seed = argc > 2 ? atoi(argv[2]) : 1;
+  std::mt19937 rng(seed);
+  shim::virtualTime = true;
+
+  // millis() is 32-bit: now_s() wraps after 2^32 ms
+  const uint64_t WRAP_S = (1ULL << 32) / 1000;
+
+  uint32_t checks = 0;
+  uint32_t mismatches = runTrace(0, days, rng, checks);
+  mismatches += runTrace(WRAP_S - days * 86400ULL / 2, days, rng, checks);
+
+  printf("days %u x 2 (from boot, across millis() wrap), seed %u: %u checks, %u mismatches\n",
+         days, seed, checks, mismatches);
+  return mismatches ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+// ===== Armenda Thermostat - binary telemetry decoder (Linux host) =====
+// Decodes the CBOR frames published on thermo/main_thermostat/telemetry and
+// prints one JSON line per frame, carrying the last seen config forward so
+// every line is self-contained. The device resends the config at least once a
+// minute; until the first one arrives, lines carry only the live fields.
+//
+// Build:
+//   g++ -O2 -std=c++17 -o telemetry_decode tools/telemetry_decode.cpp
+//
+// Usage (mosquitto_sub prints each payload as hex with -F %x):
+//   mosquitto_sub -h <broker> -t thermo/main_thermostat/telemetry -F %x | ./telemetry_decode
+//
+// Enable the stream first:
+//   mosquitto_pub -h <broker> -t thermo/main_thermostat/cmd -m '{"telemetry_ms":500}'
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Must match TelemKey in main.cpp
+static const char* keyName(uint32_t k) {
+  switch (k) {
+    case 0:  return "seq";
+    case 1:  return "uptime_ms";
+    case 2:  return "mode";
+    case 3:  return "action";
+    case 4:  return "current_temp";
+    case 5:  return "target_temp";
+    case 6:  return "humidity";
+    case 7:  return "relays";
+    case 16: return "min_on_s";
+    case 17: return "min_off_s";
+    case 18: return "deadband_f";
+    case 19: return "stage2_delta_f";
+    case 20: return "stage2_delay_s";
+    case 21: return "fan_with_heat";
+  }
+  return nullptr;
+}
+
+static const char* MODES[]   = { "off", "heat", "cool", "heat_cool", "fan_only" };
+static const char* ACTIONS[] = { "idle", "cooling", "heating", "fan" };
+
+struct Value {
+  enum Kind { NONE, UINT, FLOAT, BOOL } kind = NONE;
+  uint64_t u = 0;
+  double   f = 0;
+  bool     b = false;
+};
+
+struct Reader {
+  const uint8_t* p; size_t n; size_t i = 0; bool err = false;
+  uint8_t  byte()          { if (i >= n) { err = true; return 0; } return p[i++]; }
+  uint64_t be(int bytes)   { uint64_t v = 0; while (bytes--) v = (v << 8) | byte(); return v; }
+  uint64_t arg(uint8_t ai) {
+    if (ai < 24)  return ai;
+    if (ai == 24) return be(1);
+    if (ai == 25) return be(2);
+    if (ai == 26) return be(4);
+    if (ai == 27) return be(8);
+    err = true; return 0;
+  }
+  static double half(uint16_t h) {
+    int e = (h >> 10) & 0x1F, m = h & 0x3FF;
+    double v = (e == 0) ? std::ldexp(m, -24) : (e == 31) ? (m ? NAN : INFINITY) : std::ldexp(m + 1024, e - 25);
+    return (h & 0x8000) ? -v : v;
+  }
+  Value value() {
+    Value v;
+    uint8_t ib = byte(), major = ib >> 5, ai = ib & 0x1F;
+    if (major == 0) { v.kind = Value::UINT; v.u = arg(ai); }
+    else if (major == 7) {
+      if      (ai == 20 || ai == 21) { v.kind = Value::BOOL; v.b = (ai == 21); }
+      else if (ai == 25) { v.kind = Value::FLOAT; v.f = half((uint16_t)be(2)); }
+      else if (ai == 26) { uint32_t u = (uint32_t)be(4); float f; memcpy(&f, &u, 4); v.kind = Value::FLOAT; v.f = f; }
+      else if (ai == 27) { uint64_t u = be(8); memcpy(&v.f, &u, 8); v.kind = Value::FLOAT; }
+      else err = true;
+    } else {
+      err = true;  // the device only emits uint / float / bool values
+    }
+    return v;
+  }
+};
+
+static bool parseHex(const char* s, std::vector<uint8_t>& out) {
+  out.clear();
+  auto nib = [](char c) -> int {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  };
+  while (*s && *s != '\n' && *s != '\r') {
+    if (*s == ' ') { s++; continue; }
+    int hi = nib(s[0]), lo = s[1] ? nib(s[1]) : -1;
+    if (hi < 0 || lo < 0) return false;
+    out.push_back((uint8_t)(hi << 4 | lo));
+    s += 2;
+  }
+  return !out.empty();
+}
+
+int main() {
+  Value cfg[6];                 // keys 16..21, carried forward between frames
+  std::vector<uint8_t> frame;
+  char line[1024];
+  unsigned long frames = 0, bytes = 0, bad = 0;
+
+  while (fgets(line, sizeof(line), stdin)) {
+    if (!parseHex(line, frame)) continue;
+    Reader r{ frame.data(), frame.size() };
+
+    uint8_t ib = r.byte();
+    if ((ib >> 5) != 5) { bad++; continue; }
+    uint64_t pairs = r.arg(ib & 0x1F);
+
+    Value cur[8];
+    for (uint64_t k = 0; k < pairs && !r.err; k++) {
+      Value key = r.value(), val = r.value();
+      if (key.kind != Value::UINT) { r.err = true; break; }
+      if (key.u < 8) cur[key.u] = val;
+      else if (key.u >= 16 && key.u <= 21) cfg[key.u - 16] = val;
+    }
+    if (r.err) { bad++; continue; }
+    frames++; bytes += frame.size();
+
+    std::string out = "{";
+    auto emit = [&](uint32_t k, const Value& v) {
+      if (v.kind == Value::NONE) return;
+      if (out.size() > 1) out += ",";
+      char tmp[64];
+      if (k == 2 && v.kind == Value::UINT && v.u < 5)      snprintf(tmp, sizeof(tmp), "\"%s\":\"%s\"", keyName(k), MODES[v.u]);
+      else if (k == 3 && v.kind == Value::UINT && v.u < 4) snprintf(tmp, sizeof(tmp), "\"%s\":\"%s\"", keyName(k), ACTIONS[v.u]);
+      else if (v.kind == Value::UINT)  snprintf(tmp, sizeof(tmp), "\"%s\":%llu", keyName(k), (unsigned long long)v.u);
+      else if (v.kind == Value::FLOAT) snprintf(tmp, sizeof(tmp), "\"%s\":%.2f", keyName(k), v.f);
+      else                             snprintf(tmp, sizeof(tmp), "\"%s\":%s", keyName(k), v.b ? "true" : "false");
+      out += tmp;
+    };
+    for (uint32_t k = 0; k < 8; k++) emit(k, cur[k]);
+    for (uint32_t k = 0; k < 6; k++) emit(16 + k, cfg[k]);
+    out += ",\"bytes\":" + std::to_string(frame.size()) + "}";
+    puts(out.c_str());
+    fflush(stdout);
+  }
+
+  fprintf(stderr, "frames=%lu bad=%lu avg_bytes=%.1f\n", frames, bad, frames ? (double)bytes / frames : 0.0);
+  return 0;
+}
@@ -0,0 +1,83 @@
+// ===== Armenda Thermostat - command latency trace collector (Linux host) =====
+// Reads trace messages captured from thermo/main_thermostat/trace and prints
+// p50 / p99 / max for each on-device stage. If the sender put a Unix epoch
+// "ts" (milliseconds) in the command and the capture carries receive times,
+// the end-to-end round trip (command sent -> trace received) is reported too.
+//
+// Build:
+//   g++ -O2 -std=c++17 -o trace_collect tools/trace_collect.cpp
+//
+// Capture (%U prefixes each line with the receive time, Unix seconds):
+//   mosquitto_sub -h <broker> -t thermo/main_thermostat/trace -F '%U %p' > traces.txt
+//
+// Send traced commands:
+//   mosquitto_pub -h <broker> -t thermo/main_thermostat/cmd -m "{\"target_temp_f\":71,\"cid\":\"c$RANDOM\",\"ts\":$(date +%s%3N)}"
+//
+// Summarise:
+//   ./trace_collect < traces.txt
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Fields emitted by publishTrace() in main.cpp
+static const char* STAGES[] = {
+  "parse_us", "handle_us", "apply_us", "publish_us", "to_relay_us", "to_publish_us"
+};
+constexpr int N_STAGES = sizeof(STAGES) / sizeof(STAGES[0]);
+
+static bool findNumber(const char* json, const char* key, double& out) {
+  char pat[48];
+  snprintf(pat, sizeof(pat), "\"%s\":", key);
+  const char* p = strstr(json, pat);
+  if (!p) return false;
+  char* end = nullptr;
+  out = strtod(p + strlen(pat), &end);
+  return end != p + strlen(pat);
+}
+
+// Nearest-rank percentile on a sorted sample
+static double pct(const std::vector<double>& v, double q) {
+  if (v.empty()) return 0;
+  size_t rank = (size_t)(q * v.size() + 0.999999);
+  if (rank < 1) rank = 1;
+  return v[std::min(rank, v.size()) - 1];
+}
+
+static void report(const char* name, std::vector<double>& v, const char* unit) {
+  if (v.empty()) return;
+  std::sort(v.begin(), v.end());
+  printf("%-16s n=%-6zu p50=%-10.0f p99=%-10.0f max=%-10.0f %s\n",
+         name, v.size(), pct(v, 0.50), pct(v, 0.99), v.back(), unit);
+}
+
+int main() {
+  std::vector<double> stages[N_STAGES];
+  std::vector<double> roundTripMs;
+  char line[2048];
+  unsigned long skipped = 0;
+
+  while (fgets(line, sizeof(line), stdin)) {
+    const char* json = strchr(line, '{');
+    if (!json) { skipped++; continue; }
+
+    for (int i = 0; i < N_STAGES; i++) {
+      double v;
+      if (findNumber(json, STAGES[i], v)) stages[i].push_back(v);
+    }
+
+    // Optional "<unix seconds> " receive-time prefix plus an epoch-ms "ts"
+    double recvS, ts;
+    if (json != line && sscanf(line, "%lf", &recvS) == 1 && findNumber(json, "ts", ts) && ts > 1e12) {
+      double rtt = recvS * 1000.0 - ts;
+      if (rtt >= 0) roundTripMs.push_back(rtt);
+    }
+  }
+
+  for (int i = 0; i < N_STAGES; i++) report(STAGES[i], stages[i], "us");
+  report("round_trip", roundTripMs, "ms");
+  if (skipped) fprintf(stderr, "skipped %lu non-JSON lines\n", skipped);
+  return 0;
+}